@@ -0,0 +1,166 @@
+//=====[Libraries]=============================================================
+
+#include "code_entry.h"
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static int userCodeTableSlot( uint32_t packedKeys, int length );
+static int userCodeSlotFind( const userCodeTable_t* table,
+                             const codeEntry_t* entry );
+
+//=====[Implementations of public functions]===================================
+
+void codeEntryReset( codeEntry_t* entry )
+{
+    entry->packedKeys = 0;
+    entry->length = 0;
+    entry->overflow = false;
+}
+
+bool codeEntryKeyIsValid( char key )
+{
+    return ( key >= '0' && key <= '9' ) || ( key >= 'A' && key <= 'D' ) ||
+           key == '*';
+}
+
+// Only keypad keys are accepted. Keys beyond CODE_MAX_LENGTH are not
+// stored; the entry is only marked so that it can never match a user code.
+bool codeEntryKeyPush( codeEntry_t* entry, char key )
+{
+    uint32_t nibble;
+
+    if( key >= '0' && key <= '9' ) {
+        nibble = key - '0';
+    } else if( key >= 'A' && key <= 'D' ) {
+        nibble = key - 'A' + 10;
+    } else if( key == '*' ) {
+        nibble = 14;
+    } else {
+        return false;
+    }
+
+    if( entry->length >= CODE_MAX_LENGTH ) {
+        entry->overflow = true;
+        return false;
+    }
+    entry->packedKeys = ( entry->packedKeys << 4 ) | nibble;
+    entry->length++;
+    return true;
+}
+
+int codeEntryToString( const codeEntry_t* entry, char* str )
+{
+    const char nibbleToChar[] = "0123456789ABCD*";
+    int i;
+
+    for( i=0; i<entry->length; i++ ) {
+        str[i] = nibbleToChar[( entry->packedKeys >>
+                                ( 4 * ( entry->length - 1 - i ) ) ) & 0xF];
+    }
+    str[i] = '\0';
+    return i;
+}
+
+void userCodeTableInit( userCodeTable_t* table )
+{
+    int i;
+    for( i=0; i<USER_CODE_TABLE_SIZE; i++ ) {
+        table->codes[i].used = false;
+    }
+    table->numberOfCodes = 0;
+}
+
+// A code already stored is reported as such even when the table is full.
+userCodeAddResult_t userCodeAdd( userCodeTable_t* table,
+                                 const codeEntry_t* entry )
+{
+    int slot;
+
+    if( entry->length == 0 || entry->overflow ) {
+        return USER_CODE_INVALID;
+    }
+    if( userCodeFind( table, entry ) ) {
+        return USER_CODE_ALREADY_EXISTS;
+    }
+    if( table->numberOfCodes >= NUMBER_OF_USER_CODES ) {
+        return USER_CODE_TABLE_FULL;
+    }
+
+    slot = userCodeTableSlot( entry->packedKeys, entry->length );
+    while( table->codes[slot].used ) {
+        slot = ( slot + 1 ) % USER_CODE_TABLE_SIZE;
+    }
+    table->codes[slot].packedKeys = entry->packedKeys;
+    table->codes[slot].length = entry->length;
+    table->codes[slot].used = true;
+    table->numberOfCodes++;
+    return USER_CODE_ADDED;
+}
+
+bool userCodeFind( const userCodeTable_t* table, const codeEntry_t* entry )
+{
+    return userCodeSlotFind( table, entry ) >= 0;
+}
+
+bool userCodeRemove( userCodeTable_t* table, const codeEntry_t* entry )
+{
+    codeEntry_t movedCode;
+    int slot = userCodeSlotFind( table, entry );
+
+    if( slot < 0 || table->numberOfCodes <= 1 ) {
+        return false;
+    }
+    table->codes[slot].used = false;
+    table->numberOfCodes--;
+
+    // Codes further along the same probe run are added again, so that a
+    // lookup never stops early at the freed slot
+    slot = ( slot + 1 ) % USER_CODE_TABLE_SIZE;
+    while( table->codes[slot].used ) {
+        movedCode.packedKeys = table->codes[slot].packedKeys;
+        movedCode.length = table->codes[slot].length;
+        movedCode.overflow = false;
+        table->codes[slot].used = false;
+        table->numberOfCodes--;
+        userCodeAdd( table, &movedCode );
+        slot = ( slot + 1 ) % USER_CODE_TABLE_SIZE;
+    }
+    return true;
+}
+
+//=====[Implementations of private functions]==================================
+
+// Multiplicative hashing: the top bits of the product depend on every bit
+// of the key, the bottom ones only on the bottom bits of the key.
+static int userCodeTableSlot( uint32_t packedKeys, int length )
+{
+    uint32_t hash = ( packedKeys ^ (uint32_t) length ) * 2654435761u;
+    return hash >> ( 32 - USER_CODE_TABLE_BITS );
+}
+
+// The table is never more than half full, so a lookup only visits a slot
+// or two whatever the code length or number of user codes. Returns the
+// slot holding the code of entry, or -1.
+static int userCodeSlotFind( const userCodeTable_t* table,
+                             const codeEntry_t* entry )
+{
+    int slot;
+    int probes;
+
+    if( entry->length == 0 || entry->overflow ) {
+        return -1;
+    }
+
+    slot = userCodeTableSlot( entry->packedKeys, entry->length );
+    for( probes=0; probes<USER_CODE_TABLE_SIZE; probes++ ) {
+        if( !table->codes[slot].used ) {
+            return -1;
+        }
+        if( table->codes[slot].packedKeys == entry->packedKeys &&
+            table->codes[slot].length == entry->length ) {
+            return slot;
+        }
+        slot = ( slot + 1 ) % USER_CODE_TABLE_SIZE;
+    }
+    return -1;
+}
@@ -0,0 +1,61 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _CODE_ENTRY_H_
+#define _CODE_ENTRY_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+
+//=====[Declaration of public defines]=========================================
+
+#define CODE_MAX_LENGTH                          8
+#define NUMBER_OF_USER_CODES                     4
+#define USER_CODE_TABLE_BITS                     3
+#define USER_CODE_TABLE_SIZE                     (1 << USER_CODE_TABLE_BITS)
+
+//=====[Declaration of public data types]======================================
+
+// Keys are packed one nibble each into a single word as they arrive, so a
+// code is compared as one integer no matter how many keys it has.
+typedef struct codeEntry {
+    uint32_t packedKeys;
+    int length;
+    bool overflow;
+} codeEntry_t;
+
+typedef struct userCode {
+    uint32_t packedKeys;
+    int length;
+    bool used;
+} userCode_t;
+
+typedef enum {
+    USER_CODE_ADDED,
+    USER_CODE_ALREADY_EXISTS,
+    USER_CODE_TABLE_FULL,
+    USER_CODE_INVALID
+} userCodeAddResult_t;
+
+// Open addressing with linear probing, kept at most half full
+typedef struct userCodeTable {
+    userCode_t codes[USER_CODE_TABLE_SIZE];
+    int numberOfCodes;
+} userCodeTable_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void codeEntryReset( codeEntry_t* entry );
+bool codeEntryKeyIsValid( char key );
+bool codeEntryKeyPush( codeEntry_t* entry, char key );
+int codeEntryToString( const codeEntry_t* entry, char* str );
+
+void userCodeTableInit( userCodeTable_t* table );
+userCodeAddResult_t userCodeAdd( userCodeTable_t* table,
+                                 const codeEntry_t* entry );
+bool userCodeFind( const userCodeTable_t* table, const codeEntry_t* entry );
+bool userCodeRemove( userCodeTable_t* table, const codeEntry_t* entry );
+
+//=====[#include guards - end]=================================================
+
+#endif // _CODE_ENTRY_H_
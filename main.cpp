@@ -2,10 +2,11 @@
 
 #include "mbed.h"
 #include "arm_book_lib.h"
+#include "code_entry.h"
+#include "panel_link.h"
 
 //=====[Defines]===============================================================
 
-#define NUMBER_OF_KEYS                           3
 #define BLINKING_TIME_GAS_ALARM               1000
 #define BLINKING_TIME_OVER_TEMP_ALARM          500
 #define BLINKING_TIME_GAS_AND_OVER_TEMP_ALARM  100
@@ -17,6 +18,10 @@
 #define KEYPAD_NUMBER_OF_COLS                    4
 #define EVENT_MAX_STORAGE                      100
 #define EVENT_NAME_MAX_LENGTH                   14
+#define NUMBER_OF_DOWNSTREAM_LINKS               2
+#define DOWNSTREAM_LINK_BAUD_RATE           115200
+#define LOCAL_PANEL_ID                           0
+#define NUMBER_OF_INCORRECT_CODES_TO_BLOCK       5
 
 //=====[Declaration of public data types]======================================
 
@@ -44,6 +49,15 @@ DigitalInOut sirenPin(PE_10);
 
 UnbufferedSerial uartUsb(USBTX, USBRX, 115200);
 
+#if MBED_CONF_APP_CONCENTRATOR_ENABLED
+// Links to the uartUsb consoles of the downstream panels
+UnbufferedSerial downstreamSerial1(PD_5, PD_6, DOWNSTREAM_LINK_BAUD_RATE);
+UnbufferedSerial downstreamSerial2(PC_12, PD_2, DOWNSTREAM_LINK_BAUD_RATE);
+UnbufferedSerial* downstreamSerials[NUMBER_OF_DOWNSTREAM_LINKS] = {
+    &downstreamSerial1, &downstreamSerial2
+};
+#endif
+
 AnalogIn lm35(A1);
 
 DigitalOut keypadRowPins[KEYPAD_NUMBER_OF_ROWS] = {PB_3, PB_5, PC_7, PA_15};
@@ -52,14 +66,12 @@ DigitalIn keypadColPins[KEYPAD_NUMBER_OF_COLS]  = {PB_12, PB_13, PB_15, PC_6};
 //=====[Declaration and initialization of public global variables]=============
 
 bool alarmState    = OFF;
-bool incorrectCode = false;
 bool overTempDetector = OFF;
 
 int numberOfIncorrectCodes = 0;
 int numberOfHashKeyReleasedEvents = 0;
-int keyBeingCompared    = 0;
-char codeSequence[NUMBER_OF_KEYS]   = { '1', '8', '0' };
-char keyPressed[NUMBER_OF_KEYS] = { '0', '0', '0' };
+codeEntry_t keypadCodeEntry;
+userCodeTable_t userCodeTable;
 int accumulatedTimeAlarm = 0;
 
 bool alarmLastState        = OFF;
@@ -78,7 +90,6 @@ float lm35ReadingsArray[NUMBER_OF_AVG_SAMPLES];
 float lm35TempC            = 0.0;
 
 int accumulatedDebounceMatrixKeypadTime = 0;
-int matrixKeypadCodeIndex = 0;
 char matrixKeypadLastKeyPressed = '\0';
 char matrixKeypadIndexToCharArray[] = {
     '1', '2', '3', 'A',
@@ -91,6 +102,14 @@ matrixKeypadState_t matrixKeypadState;
 int eventsIndex            = 0;
 systemEvent_t arrayOfStoredEvents[EVENT_MAX_STORAGE];
 
+int upstreamEventSequence = 0;
+
+#if MBED_CONF_APP_CONCENTRATOR_ENABLED
+downstreamLink_t downstreamLinks[NUMBER_OF_DOWNSTREAM_LINKS];
+
+mergedEventLog_t mergedEventLog;
+#endif
+
 //=====[Declarations (prototypes) of public functions]=========================
 
 void inputsInit();
@@ -100,8 +119,11 @@ void alarmActivationUpdate();
 void alarmDeactivationUpdate();
 
 void uartTask();
+char uartUsbCharRead();
+void uartCodeEntryRead( codeEntry_t* entry, bool digitsOnly );
+bool systemIsBlocked();
+bool codeAttemptCheck( const codeEntry_t* entry );
 void availableCommands();
-bool areEqual();
 
 void eventLogUpdate();
 void systemElementStateUpdate( bool lastState,
@@ -116,28 +138,40 @@ void matrixKeypadInit();
 char matrixKeypadScan();
 char matrixKeypadUpdate();
 
+
+void upstreamFrameWrite( const char* payload );
+void upstreamStatusFrameWrite();
+
+void downstreamLinksInit();
+void downstreamLinksUpdate();
+void downstreamLinkRxIsr( int linkIndex );
+void downstreamLink1RxIsr();
+void downstreamLink2RxIsr();
+void panelStatusReport( int panelId, const panelStatus_t* status );
+void lostEventsReport();
+
 //=====[Main function, the program entry point after power on or reset]========
 
 int main()
 {
     inputsInit();
     outputsInit();
-	uartUsb.write("Enter 3‑digit deactivation code, end with '#'\r\n> ", 49);
+    uartUsb.write("Enter deactivation code (up to 8 digits), end with '#'\r\n> ", 58);
 
     // 2) Read new code from keypad
-    char newCode[NUMBER_OF_KEYS] = {0};
-    int  idx = 0;
+    codeEntry_t newCode;
+    codeEntryReset(&newCode);
     while (true) {
         char key = matrixKeypadUpdate();
         if (key != '\0') {
 
             // digit?
-            if (key >= '0' && key <= '9' && idx < NUMBER_OF_KEYS) {
-                newCode[idx++] = key;
+            if (key >= '0' && key <= '9' && newCode.length < CODE_MAX_LENGTH) {
+                codeEntryKeyPush(&newCode, key);
                 uartUsb.write(&key, 1);    // echo digit
             }
-            // end entry on '#' once 3 digits collected
-            if (key == '#' && idx == NUMBER_OF_KEYS) {
+            // end entry on '#' once at least one digit collected
+            if (key == '#' && newCode.length > 0) {
                 uartUsb.write("\r\n", 2);
                 break;
             }
@@ -145,15 +179,15 @@ int main()
     }
 
     // 3) Save the new code
-    for (int i = 0; i < NUMBER_OF_KEYS; i++) {
-        codeSequence[i] = newCode[i];
-    }
+    userCodeTableInit(&userCodeTable);
+    userCodeAdd(&userCodeTable, &newCode);
+    codeEntryReset(&keypadCodeEntry);
+
     // 4) Echo the newly set code back to the user
+    char codeStr[CODE_MAX_LENGTH + 1];
     char buf[32];
-    int len = sprintf(buf, "New code is: %c %c %c\r\n",
-                      codeSequence[0],
-                      codeSequence[1],
-                      codeSequence[2]);
+    codeEntryToString(&newCode, codeStr);
+    int len = sprintf(buf, "New code is: %s\r\n", codeStr);
     uartUsb.write(buf, len);
 
     uartUsb.write("Code set. System ready.\r\n", 27);
@@ -162,6 +196,9 @@ int main()
         alarmDeactivationUpdate();
         uartTask();
         eventLogUpdate();
+#if MBED_CONF_APP_CONCENTRATOR_ENABLED
+        downstreamLinksUpdate();
+#endif
         delay(TIME_INCREMENT_MS);
     }
 }
@@ -175,6 +212,9 @@ void inputsInit()
     sirenPin.mode(OpenDrain);
     sirenPin.input();
     matrixKeypadInit();
+#if MBED_CONF_APP_CONCENTRATOR_ENABLED
+    downstreamLinksInit();
+#endif
 }
 
 void outputsInit()
@@ -252,16 +292,11 @@ void alarmActivationUpdate()
 
 void alarmDeactivationUpdate()
 {
-    if ( numberOfIncorrectCodes < 5 ) {
+    if ( !systemIsBlocked() ) {
         char keyReleased = matrixKeypadUpdate();
         if( keyReleased != '\0' && keyReleased != '#' ) {
-            keyPressed[matrixKeypadCodeIndex] = keyReleased;
+            codeEntryKeyPush( &keypadCodeEntry, keyReleased );
             uartUsb.write(&keyReleased, 1);    // echo digit
-            if( matrixKeypadCodeIndex >= NUMBER_OF_KEYS ) {
-                matrixKeypadCodeIndex = 0;
-            } else {
-                matrixKeypadCodeIndex++;
-            }
         }
         if( keyReleased == '#' ) {
             uartUsb.write("\r\n", 2);
@@ -270,20 +305,15 @@ void alarmDeactivationUpdate()
                 if( numberOfHashKeyReleasedEvents >= 2 ) {
                     incorrectCodeLed = OFF;
                     numberOfHashKeyReleasedEvents = 0;
-                    matrixKeypadCodeIndex = 0;
                 }
             } else {
                 if ( alarmState ) {
-                    if ( areEqual() ) {
+                    if ( codeAttemptCheck( &keypadCodeEntry ) ) {
                         alarmState = OFF;
-                        numberOfIncorrectCodes = 0;
-                        matrixKeypadCodeIndex = 0;
-                    } else {
-                        incorrectCodeLed = ON;
-                        numberOfIncorrectCodes++;
                     }
                 }
             }
+            codeEntryReset( &keypadCodeEntry );
         }
     } else {
         systemBlockedLed = ON;
@@ -295,6 +325,7 @@ void uartTask()
     char receivedChar = '\0';
     char str[100];
     int stringLength;
+    codeEntry_t uartCodeEntry;
     if( uartUsb.readable() ) {
         uartUsb.read( &receivedChar, 1 );
         switch (receivedChar) {
@@ -323,45 +354,74 @@ void uartTask()
             break;
             
         case '4':
-            uartUsb.write( "Please enter the three digits numeric code ", 42 );
-            uartUsb.write( "to deactivate the alarm: ", 25 );
-
-            incorrectCode = false;
-
-            for ( keyBeingCompared = 0;
-                  keyBeingCompared < NUMBER_OF_KEYS;
-                  keyBeingCompared++) {
-                uartUsb.read( &receivedChar, 1 );
-                uartUsb.write( "*", 1 );
-                if ( codeSequence[keyBeingCompared] != receivedChar ) {
-                    incorrectCode = true;
-                }
+            if ( systemIsBlocked() ) {
+                uartUsb.write( "The system is blocked\r\n\r\n", 25 );
+                break;
             }
+            uartUsb.write( "Please enter the numeric code to deactivate ", 44 );
+            uartUsb.write( "the alarm, end with '#': ", 25 );
+
+            uartCodeEntryRead( &uartCodeEntry, false );
 
-            if ( incorrectCode == false ) {
+            if ( codeAttemptCheck( &uartCodeEntry ) ) {
                 uartUsb.write( "\r\nThe code is correct\r\n\r\n", 25 );
                 alarmState = OFF;
                 incorrectCodeLed = OFF;
-                numberOfIncorrectCodes = 0;
             } else {
                 uartUsb.write( "\r\nThe code is incorrect\r\n\r\n", 27 );
-                incorrectCodeLed = ON;
-                numberOfIncorrectCodes++;
             }
             break;
 
         case '5':
-            uartUsb.write( "Please enter the new three digits numeric code ", 46 );
-            uartUsb.write( "to deactivate the alarm: ", 25 );
-
-            for ( keyBeingCompared = 0;
-                  keyBeingCompared < NUMBER_OF_KEYS;
-                  keyBeingCompared++) {
-                uartUsb.read( &receivedChar, 1 );
-                uartUsb.write( "*", 1 );
+            if ( systemIsBlocked() ) {
+                uartUsb.write( "The system is blocked\r\n\r\n", 25 );
+                break;
+            }
+            uartUsb.write( "Please enter a current code, end with '#': ", 43 );
+            uartCodeEntryRead( &uartCodeEntry, false );
+            if ( !codeAttemptCheck( &uartCodeEntry ) ) {
+                uartUsb.write( "\r\nThe code is incorrect\r\n\r\n", 27 );
+                break;
+            }
+
+            uartUsb.write( "\r\nPlease enter the new numeric code to deactivate ", 50 );
+            uartUsb.write( "the alarm, end with '#': ", 25 );
+            uartCodeEntryRead( &uartCodeEntry, true );
+
+            switch ( userCodeAdd( &userCodeTable, &uartCodeEntry ) ) {
+            case USER_CODE_ADDED:
+                uartUsb.write( "\r\nNew code added\r\n\r\n", 20 );
+                break;
+            case USER_CODE_ALREADY_EXISTS:
+                uartUsb.write( "\r\nCode already exists\r\n\r\n", 25 );
+                break;
+            case USER_CODE_TABLE_FULL:
+                uartUsb.write( "\r\nNo more codes can be added\r\n\r\n", 32 );
+                break;
+            default:
+                uartUsb.write( "\r\nThe code could not be added\r\n\r\n", 33 );
+                break;
+            }
+            break;
+
+        case '6':
+            if ( systemIsBlocked() ) {
+                uartUsb.write( "The system is blocked\r\n\r\n", 25 );
+                break;
+            }
+            uartUsb.write( "Please enter the code to remove, end with '#': ", 47 );
+            uartCodeEntryRead( &uartCodeEntry, false );
+            if ( !codeAttemptCheck( &uartCodeEntry ) ) {
+                uartUsb.write( "\r\nThe code is incorrect\r\n\r\n", 27 );
+                break;
             }
 
-            uartUsb.write( "\r\nNew code generated\r\n\r\n", 24 );
+            // The last code is kept so that the alarm can still be deactivated
+            if ( userCodeRemove( &userCodeTable, &uartCodeEntry ) ) {
+                uartUsb.write( "\r\nCode removed\r\n\r\n", 18 );
+            } else {
+                uartUsb.write( "\r\nThe last code cannot be removed\r\n\r\n", 37 );
+            }
             break;
 
         case 'c':
@@ -386,7 +446,7 @@ void uartTask()
                     
             uartUsb.write( "\r\nType four digits for the current year (YYYY): ", 48 );
             for( strIndex=0; strIndex<4; strIndex++ ) {
-                uartUsb.read( &str[strIndex] , 1 );
+                str[strIndex] = uartUsbCharRead();
                 uartUsb.write( &str[strIndex] ,1 );
             }
             str[4] = '\0';
@@ -395,7 +455,7 @@ void uartTask()
 
             uartUsb.write( "Type two digits for the current month (01-12): ", 47 );
             for( strIndex=0; strIndex<2; strIndex++ ) {
-                uartUsb.read( &str[strIndex] , 1 );
+                str[strIndex] = uartUsbCharRead();
                 uartUsb.write( &str[strIndex] ,1 );
             }
             str[2] = '\0';
@@ -404,7 +464,7 @@ void uartTask()
 
             uartUsb.write( "Type two digits for the current day (01-31): ", 45 );
             for( strIndex=0; strIndex<2; strIndex++ ) {
-                uartUsb.read( &str[strIndex] , 1 );
+                str[strIndex] = uartUsbCharRead();
                 uartUsb.write( &str[strIndex] ,1 );
             }
             str[2] = '\0';
@@ -413,7 +473,7 @@ void uartTask()
 
             uartUsb.write( "Type two digits for the current hour (00-23): ", 46 );
             for( strIndex=0; strIndex<2; strIndex++ ) {
-                uartUsb.read( &str[strIndex] , 1 );
+                str[strIndex] = uartUsbCharRead();
                 uartUsb.write( &str[strIndex] ,1 );
             }
             str[2] = '\0';
@@ -422,7 +482,7 @@ void uartTask()
 
             uartUsb.write( "Type two digits for the current minutes (00-59): ", 49 );
             for( strIndex=0; strIndex<2; strIndex++ ) {
-                uartUsb.read( &str[strIndex] , 1 );
+                str[strIndex] = uartUsbCharRead();
                 uartUsb.write( &str[strIndex] ,1 );
             }
             str[2] = '\0';
@@ -431,7 +491,7 @@ void uartTask()
 
             uartUsb.write( "Type two digits for the current seconds (00-59): ", 49 );
             for( strIndex=0; strIndex<2; strIndex++ ) {
-                uartUsb.read( &str[strIndex] , 1 );
+                str[strIndex] = uartUsbCharRead();
                 uartUsb.write( &str[strIndex] ,1 );
             }
             str[2] = '\0';
@@ -466,6 +526,54 @@ void uartTask()
                 }
                 break;
 
+#if MBED_CONF_APP_CONCENTRATOR_ENABLED
+            case 'm':
+            case 'M':
+                for (int i = 0; i < mergedEventLog.numberOfEvents; i++) {
+                    sprintf ( str, "Panel %d event = %s\r\n",
+                        mergedEventLog.events[i].panelId,
+                        mergedEventLog.events[i].typeOfEvent);
+                    uartUsb.write( str , strlen(str) );
+                    sprintf ( str, "Date and Time = %s\r\n",
+                        ctime(&mergedEventLog.events[i].seconds));
+                    uartUsb.write( str , strlen(str) );
+                    uartUsb.write( "\r\n", 2 );
+                }
+                lostEventsReport();
+                break;
+
+            case 'p':
+            case 'P': {
+                panelStatus_t localStatus;
+                localStatus.online           = true;
+                localStatus.alarm            = alarmState;
+                localStatus.gasDetector      = !mq2;
+                localStatus.overTempDetector = overTempDetector;
+                localStatus.incorrectCode    = incorrectCodeLed;
+                localStatus.systemBlocked    = systemBlockedLed;
+                panelStatusReport( LOCAL_PANEL_ID, &localStatus );
+                for (int i = 0; i < NUMBER_OF_DOWNSTREAM_LINKS; i++) {
+                    panelStatusReport( i + 1, &downstreamLinks[i].status );
+                }
+                lostEventsReport();
+                uartUsb.write( "\r\n", 2 );
+                break;
+            }
+
+#endif
+
+#if MBED_CONF_APP_UPSTREAM_FRAMES_ENABLED
+            // Status poll sent by an upstream concentrator
+            case DOWNSTREAM_POLL_REQUEST:
+                upstreamStatusFrameWrite();
+                break;
+#endif
+
+        // Line endings left over from a previous entry are not commands
+        case '\r':
+        case '\n':
+            break;
+
         default:
             availableCommands();
             break;
@@ -474,6 +582,76 @@ void uartTask()
     }
 }
 
+// Blocks until the next console character, but keeps the downstream links
+// serviced meanwhile so that the panels are not seen as offline. A status
+// poll from an upstream concentrator is answered, not taken as typed input.
+char uartUsbCharRead()
+{
+    char receivedChar;
+
+    while( true ) {
+        while( !uartUsb.readable() ) {
+#if MBED_CONF_APP_CONCENTRATOR_ENABLED
+            downstreamLinksUpdate();
+#endif
+            delay(TIME_INCREMENT_MS);
+        }
+        uartUsb.read( &receivedChar, 1 );
+#if MBED_CONF_APP_UPSTREAM_FRAMES_ENABLED
+        if( receivedChar == DOWNSTREAM_POLL_REQUEST ) {
+            upstreamStatusFrameWrite();
+            continue;
+        }
+#endif
+        return receivedChar;
+    }
+}
+
+// Reads a code from the console until '#' or Enter, echoing '*' per key.
+// Line endings before the first key are skipped, so that the '\n' of a
+// CRLF ending the previous entry does not end this one.
+void uartCodeEntryRead( codeEntry_t* entry, bool digitsOnly )
+{
+    char receivedChar;
+
+    codeEntryReset( entry );
+    receivedChar = uartUsbCharRead();
+    while ( receivedChar != '#' ) {
+        if ( receivedChar == '\r' || receivedChar == '\n' ) {
+            if ( entry->length > 0 || entry->overflow ) {
+                break;
+            }
+        } else if ( codeEntryKeyIsValid( receivedChar ) &&
+                    ( !digitsOnly ||
+                      ( receivedChar >= '0' && receivedChar <= '9' ) ) ) {
+            codeEntryKeyPush( entry, receivedChar );
+            uartUsb.write( "*", 1 );
+        }
+        receivedChar = uartUsbCharRead();
+    }
+}
+
+bool systemIsBlocked()
+{
+    return numberOfIncorrectCodes >= NUMBER_OF_INCORRECT_CODES_TO_BLOCK;
+}
+
+// Every code attempt, from the keypad or the UART, goes through here so
+// that both count towards the same lockout.
+bool codeAttemptCheck( const codeEntry_t* entry )
+{
+    if ( userCodeFind( &userCodeTable, entry ) ) {
+        numberOfIncorrectCodes = 0;
+        return true;
+    }
+    incorrectCodeLed = ON;
+    numberOfIncorrectCodes++;
+    if ( systemIsBlocked() ) {
+        systemBlockedLed = ON;
+    }
+    return false;
+}
+
 void availableCommands()
 {
     uartUsb.write( "Available commands:\r\n", 21 );
@@ -481,25 +659,18 @@ void availableCommands()
     uartUsb.write( "Press '2' to get the gas detector state\r\n", 41 );
     uartUsb.write( "Press '3' to get the over temperature detector state\r\n", 54 );
     uartUsb.write( "Press '4' to enter the code sequence\r\n", 38 );
-    uartUsb.write( "Press '5' to enter a new code\r\n", 31 );
+    uartUsb.write( "Press '5' to add a new code\r\n", 29 );
+    uartUsb.write( "Press '6' to remove a code\r\n", 28 );
     uartUsb.write( "Press 'f' or 'F' to get lm35 reading in Fahrenheit\r\n", 52 );
     uartUsb.write( "Press 'c' or 'C' to get lm35 reading in Celsius\r\n", 49 );
     uartUsb.write( "Press 's' or 'S' to set the date and time\r\n", 43 );
     uartUsb.write( "Press 't' or 'T' to get the date and time\r\n", 43 );
-    uartUsb.write( "Press 'e' or 'E' to get the stored events\r\n\r\n", 45 );
-}
-
-bool areEqual()
-{
-    int i;
-
-    for (i = 0; i < NUMBER_OF_KEYS; i++) {
-        if (codeSequence[i] != keyPressed[i]) {
-            return false;
-        }
-    }
-
-    return true;
+    uartUsb.write( "Press 'e' or 'E' to get the stored events\r\n", 43 );
+#if MBED_CONF_APP_CONCENTRATOR_ENABLED
+    uartUsb.write( "Press 'm' or 'M' to get the merged events of all panels\r\n", 57 );
+    uartUsb.write( "Press 'p' or 'P' to get the status of all panels\r\n", 50 );
+#endif
+    uartUsb.write( "\r\n", 2 );
 }
 
 void eventLogUpdate()
@@ -553,6 +724,19 @@ void systemElementStateUpdate(bool lastState,
     int n = snprintf(outBuf, sizeof(outBuf),
         "%s  %s\r\n", timeBuf, eventStr);
     uartUsb.write(outBuf, n);
+
+#if MBED_CONF_APP_UPSTREAM_FRAMES_ENABLED
+    // 5) Same event as a frame for an upstream concentrator
+    snprintf(outBuf, sizeof(outBuf), "E,%d,%lu,%s",
+        upstreamEventSequence, (unsigned long) now, eventStr);
+    upstreamFrameWrite(outBuf);
+    upstreamEventSequence =
+        (upstreamEventSequence + 1) % DOWNSTREAM_EVENT_SEQUENCE_MODULO;
+#endif
+
+#if MBED_CONF_APP_CONCENTRATOR_ENABLED
+    mergedEventLogInsert(&mergedEventLog, now, LOCAL_PANEL_ID, eventStr);
+#endif
 }
 
 float analogReadingScaledWithTheLM35Formula( float analogReading )
@@ -650,3 +834,112 @@ char matrixKeypadUpdate()
     }
     return keyReleased;
 }
+
+void upstreamFrameWrite( const char* payload )
+{
+    char outBuf[DOWNSTREAM_FRAME_MAX_LENGTH + 8];
+    int n = downstreamFrameEncode( outBuf, sizeof(outBuf), payload );
+    uartUsb.write( outBuf, n );
+}
+
+void upstreamStatusFrameWrite()
+{
+    char payload[20];
+    snprintf( payload, sizeof(payload), "S,%d,%d,%d,%d,%d,%d",
+              alarmState ? 1 : 0,
+              !mq2 ? 1 : 0,
+              overTempDetector ? 1 : 0,
+              incorrectCodeLed ? 1 : 0,
+              systemBlockedLed ? 1 : 0,
+              upstreamEventSequence );
+    upstreamFrameWrite( payload );
+}
+
+#if MBED_CONF_APP_CONCENTRATOR_ENABLED
+
+void downstreamLinksInit()
+{
+    int i;
+
+    for( i=0; i<NUMBER_OF_DOWNSTREAM_LINKS; i++ ) {
+        downstreamLinkInit( &downstreamLinks[i] );
+    }
+    mergedEventLogInit( &mergedEventLog );
+
+    downstreamSerial1.attach( &downstreamLink1RxIsr, SerialBase::RxIrq );
+    downstreamSerial2.attach( &downstreamLink2RxIsr, SerialBase::RxIrq );
+}
+
+void downstreamLinksUpdate()
+{
+    const char pollRequest = DOWNSTREAM_POLL_REQUEST;
+    bool pollDue;
+    int i;
+
+    for( i=0; i<NUMBER_OF_DOWNSTREAM_LINKS; i++ ) {
+        downstreamLinkUpdate( &downstreamLinks[i], &mergedEventLog, i + 1,
+                              TIME_INCREMENT_MS, &pollDue );
+        if( pollDue ) {
+            downstreamSerials[i]->write( &pollRequest, 1 );
+        }
+    }
+}
+
+// The UART keeps a single received byte, so it is moved to the ring buffer
+// as soon as it arrives; bytes are dropped only if the buffer is full.
+void downstreamLinkRxIsr( int linkIndex )
+{
+    char receivedByte;
+
+    while( downstreamSerials[linkIndex]->readable() ) {
+        downstreamSerials[linkIndex]->read( &receivedByte, 1 );
+        downstreamRingBufferPush( &downstreamLinks[linkIndex].rxBuffer,
+                                  receivedByte );
+    }
+}
+
+void downstreamLink1RxIsr()
+{
+    downstreamLinkRxIsr( 0 );
+}
+
+void downstreamLink2RxIsr()
+{
+    downstreamLinkRxIsr( 1 );
+}
+
+void panelStatusReport( int panelId, const panelStatus_t* status )
+{
+    char str[100];
+
+    if( !status->online ) {
+        sprintf( str, "Panel %d: offline\r\n", panelId );
+    } else {
+        sprintf( str, "Panel %d: ALARM %s, GAS %s, OVER_TEMP %s, "
+                 "LED_IC %s, LED_SB %s\r\n", panelId,
+                 status->alarm            ? "ON" : "OFF",
+                 status->gasDetector      ? "ON" : "OFF",
+                 status->overTempDetector ? "ON" : "OFF",
+                 status->incorrectCode    ? "ON" : "OFF",
+                 status->systemBlocked    ? "ON" : "OFF" );
+    }
+    uartUsb.write( str, strlen(str) );
+}
+
+// Events a panel sent while its RX buffer was full are missing from the
+// merged log; the gaps in their numbering are reported instead.
+void lostEventsReport()
+{
+    char str[50];
+    int i;
+
+    for( i=0; i<NUMBER_OF_DOWNSTREAM_LINKS; i++ ) {
+        if( downstreamLinks[i].numberOfLostEvents > 0 ) {
+            sprintf( str, "Panel %d: %d event(s) lost\r\n", i + 1,
+                     downstreamLinks[i].numberOfLostEvents );
+            uartUsb.write( str, strlen(str) );
+        }
+    }
+}
+
+#endif // MBED_CONF_APP_CONCENTRATOR_ENABLED
@@ -0,0 +1,336 @@
+//=====[Libraries]=============================================================
+
+#include "panel_link.h"
+
+#include <stdio.h>
+#include <string.h>
+
+//=====[Declarations (prototypes) of private functions]========================
+
+static downstreamFrameType_t downstreamFrameDecode( downstreamFrameParser_t* parser,
+                                                    downstreamFrame_t* frame );
+static bool decimalFieldDecode( const char* payload, int* index, int maxDigits,
+                                unsigned long* value );
+static bool hexDigitToValue( char hexDigit, int* value );
+static bool statusFlagDecode( char flag, bool* value );
+static void lostEventsCount( downstreamLink_t* link, int sequence );
+
+//=====[Implementations of public functions]===================================
+
+void downstreamRingBufferInit( downstreamRingBuffer_t* ringBuffer )
+{
+    ringBuffer->head = 0;
+    ringBuffer->tail = 0;
+}
+
+bool downstreamRingBufferPush( downstreamRingBuffer_t* ringBuffer, char byte )
+{
+    int nextHead = ( ringBuffer->head + 1 ) % DOWNSTREAM_RX_BUFFER_SIZE;
+    if( nextHead == ringBuffer->tail ) {
+        return false;
+    }
+    ringBuffer->data[ringBuffer->head] = byte;
+    ringBuffer->head = nextHead;
+    return true;
+}
+
+bool downstreamRingBufferPop( downstreamRingBuffer_t* ringBuffer, char* byte )
+{
+    if( ringBuffer->head == ringBuffer->tail ) {
+        return false;
+    }
+    *byte = ringBuffer->data[ringBuffer->tail];
+    ringBuffer->tail = ( ringBuffer->tail + 1 ) % DOWNSTREAM_RX_BUFFER_SIZE;
+    return true;
+}
+
+// Frames are "$<payload>*<hh>\r\n" where hh is the XOR of the payload bytes
+// in hex, so a concentrator can pick them out of the regular console text.
+// Returns the frame length, or 0 if the payload is too long for a parser.
+int downstreamFrameEncode( char* frame, int frameSize, const char* payload )
+{
+    unsigned char checksum = 0;
+    int payloadLength = strlen( payload );
+    int i;
+
+    if( payloadLength + 3 >= DOWNSTREAM_FRAME_MAX_LENGTH ||
+        payloadLength + 7 > frameSize ) {
+        return 0;
+    }
+    for( i=0; i<payloadLength; i++ ) {
+        checksum ^= (unsigned char) payload[i];
+    }
+    return snprintf( frame, frameSize, "$%s*%02X\r\n", payload, checksum );
+}
+
+void downstreamFrameParserInit( downstreamFrameParser_t* parser )
+{
+    parser->frameLength = 0;
+    parser->frameInProgress = false;
+}
+
+// Feeds one received byte; returns the type of frame completed by it, with
+// its content in frame, or DOWNSTREAM_FRAME_NONE.
+downstreamFrameType_t downstreamFrameByteProcess( downstreamFrameParser_t* parser,
+                                                  char receivedByte,
+                                                  downstreamFrame_t* frame )
+{
+    if( receivedByte == '$' ) {
+        parser->frameInProgress = true;
+        parser->frameLength = 0;
+        return DOWNSTREAM_FRAME_NONE;
+    }
+    if( !parser->frameInProgress ) {
+        return DOWNSTREAM_FRAME_NONE;
+    }
+    if( receivedByte == '\r' || receivedByte == '\n' ) {
+        parser->frameInProgress = false;
+        return downstreamFrameDecode( parser, frame );
+    }
+    if( parser->frameLength >= DOWNSTREAM_FRAME_MAX_LENGTH - 1 ) {
+        parser->frameInProgress = false;
+        return DOWNSTREAM_FRAME_NONE;
+    }
+    parser->frame[parser->frameLength++] = receivedByte;
+    return DOWNSTREAM_FRAME_NONE;
+}
+
+void downstreamLinkInit( downstreamLink_t* link )
+{
+    downstreamRingBufferInit( &link->rxBuffer );
+    downstreamFrameParserInit( &link->frameParser );
+    link->accumulatedTimeSinceLastFrame = 0;
+    link->accumulatedTimeSincePoll = 0;
+    link->nextEventSequence = 0;
+    link->numberOfLostEvents = 0;
+    memset( &link->status, 0, sizeof(panelStatus_t) );
+}
+
+// Service step of one link, run once per main loop pass: parses what the RX
+// interrupt has buffered, advances the link timers by elapsedMs, marks the
+// panel offline after DOWNSTREAM_LINK_TIMEOUT_MS without a valid frame and
+// sets pollDue when a status poll should be sent to the panel. Only a status
+// frame brings a panel online, so that its flags are never stale; an event
+// from an offline panel asks for one straight away. While the panel is
+// online, gaps in its event numbering are added to numberOfLostEvents; the
+// numbering is picked up again from the status frame that brings it back.
+void downstreamLinkUpdate( downstreamLink_t* link, mergedEventLog_t* log,
+                           int panelId, int elapsedMs, bool* pollDue )
+{
+    downstreamFrame_t frame;
+    char receivedByte;
+    bool statusNeeded = false;
+
+    while( downstreamRingBufferPop( &link->rxBuffer, &receivedByte ) ) {
+        switch( downstreamFrameByteProcess( &link->frameParser,
+                                            receivedByte, &frame ) ) {
+        case DOWNSTREAM_FRAME_EVENT:
+            mergedEventLogInsert( log, frame.seconds, panelId,
+                                  frame.typeOfEvent );
+            link->accumulatedTimeSinceLastFrame = 0;
+            if( link->status.online ) {
+                lostEventsCount( link, frame.sequence );
+                link->nextEventSequence = ( frame.sequence + 1 ) %
+                                          DOWNSTREAM_EVENT_SEQUENCE_MODULO;
+            } else {
+                statusNeeded = true;
+            }
+            break;
+        case DOWNSTREAM_FRAME_STATUS:
+            if( link->status.online ) {
+                lostEventsCount( link, frame.sequence );
+            }
+            link->nextEventSequence = frame.sequence;
+            link->status = frame.status;
+            link->accumulatedTimeSinceLastFrame = 0;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if( link->accumulatedTimeSinceLastFrame < DOWNSTREAM_LINK_TIMEOUT_MS ) {
+        link->accumulatedTimeSinceLastFrame =
+            link->accumulatedTimeSinceLastFrame + elapsedMs;
+    }
+    if( link->accumulatedTimeSinceLastFrame >= DOWNSTREAM_LINK_TIMEOUT_MS ) {
+        link->status.online = false;
+    }
+
+    link->accumulatedTimeSincePoll = link->accumulatedTimeSincePoll + elapsedMs;
+    *pollDue = false;
+    if( link->accumulatedTimeSincePoll >= DOWNSTREAM_POLL_TIME_MS ||
+        statusNeeded ) {
+        link->accumulatedTimeSincePoll = 0;
+        *pollDue = true;
+    }
+}
+
+void mergedEventLogInit( mergedEventLog_t* log )
+{
+    log->numberOfEvents = 0;
+}
+
+// Keeps the log sorted by time; when full the oldest event is dropped to
+// make room.
+void mergedEventLogInsert( mergedEventLog_t* log, time_t seconds, int panelId,
+                           const char* typeOfEvent )
+{
+    int insertIndex = log->numberOfEvents;
+
+    while( insertIndex > 0 &&
+           log->events[insertIndex - 1].seconds > seconds ) {
+        insertIndex--;
+    }
+
+    if( log->numberOfEvents >= MERGED_EVENT_MAX_STORAGE ) {
+        if( insertIndex == 0 ) {
+            return;
+        }
+        memmove( &log->events[0], &log->events[1],
+                 ( insertIndex - 1 ) * sizeof(mergedEvent_t) );
+        insertIndex--;
+    } else {
+        memmove( &log->events[insertIndex + 1], &log->events[insertIndex],
+                 ( log->numberOfEvents - insertIndex ) * sizeof(mergedEvent_t) );
+        log->numberOfEvents++;
+    }
+
+    log->events[insertIndex].seconds = seconds;
+    log->events[insertIndex].panelId = panelId;
+    strncpy( log->events[insertIndex].typeOfEvent, typeOfEvent,
+             MERGED_EVENT_NAME_MAX_LENGTH - 1 );
+    log->events[insertIndex].typeOfEvent[MERGED_EVENT_NAME_MAX_LENGTH - 1] = '\0';
+}
+
+//=====[Implementations of private functions]==================================
+
+// Accepts "E,<sequence>,<seconds>,<event name>" and "S,a,g,t,i,b,<sequence>"
+// (flags '0' or '1'), followed by '*' and exactly two hex digits of checksum.
+static downstreamFrameType_t downstreamFrameDecode( downstreamFrameParser_t* parser,
+                                                    downstreamFrame_t* frame )
+{
+    char* payload = parser->frame;
+    int payloadLength = parser->frameLength - 3;
+    unsigned char checksum = 0;
+    unsigned long sequence;
+    int highNibble;
+    int lowNibble;
+    int i;
+
+    if( payloadLength < 1 || payload[payloadLength] != '*' ||
+        !hexDigitToValue( payload[payloadLength + 1], &highNibble ) ||
+        !hexDigitToValue( payload[payloadLength + 2], &lowNibble ) ) {
+        return DOWNSTREAM_FRAME_NONE;
+    }
+    for( i=0; i<payloadLength; i++ ) {
+        checksum ^= (unsigned char) payload[i];
+    }
+    if( checksum != ( highNibble << 4 | lowNibble ) ) {
+        return DOWNSTREAM_FRAME_NONE;
+    }
+    payload[payloadLength] = '\0';
+
+    if( payloadLength >= 2 && payload[0] == 'E' && payload[1] == ',' ) {
+        unsigned long seconds;
+        int nameLength;
+
+        i = 2;
+        if( !decimalFieldDecode( payload, &i, 3, &sequence ) ||
+            sequence >= DOWNSTREAM_EVENT_SEQUENCE_MODULO || payload[i] != ',' ) {
+            return DOWNSTREAM_FRAME_NONE;
+        }
+        i++;
+        if( !decimalFieldDecode( payload, &i, 10, &seconds ) ||
+            payload[i] != ',' ) {
+            return DOWNSTREAM_FRAME_NONE;
+        }
+        nameLength = payloadLength - i - 1;
+        if( nameLength < 1 || nameLength >= MERGED_EVENT_NAME_MAX_LENGTH ||
+            strchr( &payload[i + 1], ',' ) != NULL ) {
+            return DOWNSTREAM_FRAME_NONE;
+        }
+        frame->type = DOWNSTREAM_FRAME_EVENT;
+        frame->sequence = sequence;
+        frame->seconds = seconds;
+        strcpy( frame->typeOfEvent, &payload[i + 1] );
+        return DOWNSTREAM_FRAME_EVENT;
+    }
+
+    if( payloadLength >= 13 && payload[0] == 'S' ) {
+        for( i=1; i<12; i=i+2 ) {
+            if( payload[i] != ',' ) {
+                return DOWNSTREAM_FRAME_NONE;
+            }
+        }
+        if( !statusFlagDecode( payload[2],  &frame->status.alarm ) ||
+            !statusFlagDecode( payload[4],  &frame->status.gasDetector ) ||
+            !statusFlagDecode( payload[6],  &frame->status.overTempDetector ) ||
+            !statusFlagDecode( payload[8],  &frame->status.incorrectCode ) ||
+            !statusFlagDecode( payload[10], &frame->status.systemBlocked ) ) {
+            return DOWNSTREAM_FRAME_NONE;
+        }
+        i = 12;
+        if( !decimalFieldDecode( payload, &i, 3, &sequence ) ||
+            sequence >= DOWNSTREAM_EVENT_SEQUENCE_MODULO ||
+            i != payloadLength ) {
+            return DOWNSTREAM_FRAME_NONE;
+        }
+        frame->status.online = true;
+        frame->type = DOWNSTREAM_FRAME_STATUS;
+        frame->sequence = sequence;
+        return DOWNSTREAM_FRAME_STATUS;
+    }
+
+    return DOWNSTREAM_FRAME_NONE;
+}
+
+// Reads 1 to maxDigits decimal digits starting at *index, leaving *index on
+// the first character after them.
+static bool decimalFieldDecode( const char* payload, int* index, int maxDigits,
+                                unsigned long* value )
+{
+    int numberOfDigits = 0;
+
+    *value = 0;
+    while( payload[*index] >= '0' && payload[*index] <= '9' ) {
+        if( ++numberOfDigits > maxDigits ) {
+            return false;
+        }
+        *value = *value * 10 + ( payload[*index] - '0' );
+        (*index)++;
+    }
+    return numberOfDigits > 0;
+}
+
+static bool hexDigitToValue( char hexDigit, int* value )
+{
+    if( hexDigit >= '0' && hexDigit <= '9' ) {
+        *value = hexDigit - '0';
+    } else if( hexDigit >= 'A' && hexDigit <= 'F' ) {
+        *value = hexDigit - 'A' + 10;
+    } else if( hexDigit >= 'a' && hexDigit <= 'f' ) {
+        *value = hexDigit - 'a' + 10;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool statusFlagDecode( char flag, bool* value )
+{
+    if( flag != '0' && flag != '1' ) {
+        return false;
+    }
+    *value = ( flag == '1' );
+    return true;
+}
+
+// Events numbered between the one expected and the one received never made
+// it through, e.g. because the RX buffer overflowed.
+static void lostEventsCount( downstreamLink_t* link, int sequence )
+{
+    link->numberOfLostEvents = link->numberOfLostEvents +
+        ( sequence - link->nextEventSequence +
+          DOWNSTREAM_EVENT_SEQUENCE_MODULO ) % DOWNSTREAM_EVENT_SEQUENCE_MODULO;
+}
@@ -0,0 +1,110 @@
+//=====[#include guards - begin]===============================================
+
+#ifndef _PANEL_LINK_H_
+#define _PANEL_LINK_H_
+
+//=====[Libraries]=============================================================
+
+#include <stdint.h>
+#include <time.h>
+
+//=====[Declaration of public defines]=========================================
+
+// About 90 ms of continuous traffic at 115200 baud, enough to ride out the
+// longest console write of the concentrator
+#define DOWNSTREAM_RX_BUFFER_SIZE             1024
+#define DOWNSTREAM_FRAME_MAX_LENGTH             48
+#define DOWNSTREAM_EVENT_SEQUENCE_MODULO       256
+#define DOWNSTREAM_POLL_REQUEST                'q'
+#define DOWNSTREAM_POLL_TIME_MS               1000
+#define DOWNSTREAM_LINK_TIMEOUT_MS            3000
+#define MERGED_EVENT_MAX_STORAGE               100
+#define MERGED_EVENT_NAME_MAX_LENGTH            14
+
+//=====[Declaration of public data types]======================================
+
+typedef enum {
+    DOWNSTREAM_FRAME_NONE,
+    DOWNSTREAM_FRAME_EVENT,
+    DOWNSTREAM_FRAME_STATUS
+} downstreamFrameType_t;
+
+typedef struct panelStatus {
+    bool online;
+    bool alarm;
+    bool gasDetector;
+    bool overTempDetector;
+    bool incorrectCode;
+    bool systemBlocked;
+} panelStatus_t;
+
+// Bytes are pushed at head (from the RX interrupt) and popped at tail (from
+// the main loop); one slot is kept free so that head == tail means empty.
+typedef struct downstreamRingBuffer {
+    volatile char data[DOWNSTREAM_RX_BUFFER_SIZE];
+    volatile int head;
+    volatile int tail;
+} downstreamRingBuffer_t;
+
+typedef struct downstreamFrameParser {
+    char frame[DOWNSTREAM_FRAME_MAX_LENGTH];
+    int frameLength;
+    bool frameInProgress;
+} downstreamFrameParser_t;
+
+// sequence is the number of an event frame, or in a status frame the number
+// the panel will give to its next event.
+typedef struct downstreamFrame {
+    downstreamFrameType_t type;
+    int sequence;
+    time_t seconds;
+    char typeOfEvent[MERGED_EVENT_NAME_MAX_LENGTH];
+    panelStatus_t status;
+} downstreamFrame_t;
+
+// Receive side of one link to a downstream panel, as seen by the concentrator
+typedef struct downstreamLink {
+    downstreamRingBuffer_t rxBuffer;
+    downstreamFrameParser_t frameParser;
+    int accumulatedTimeSinceLastFrame;
+    int accumulatedTimeSincePoll;
+    int nextEventSequence;
+    int numberOfLostEvents;
+    panelStatus_t status;
+} downstreamLink_t;
+
+typedef struct mergedEvent {
+    time_t seconds;
+    int panelId;
+    char typeOfEvent[MERGED_EVENT_NAME_MAX_LENGTH];
+} mergedEvent_t;
+
+typedef struct mergedEventLog {
+    mergedEvent_t events[MERGED_EVENT_MAX_STORAGE];
+    int numberOfEvents;
+} mergedEventLog_t;
+
+//=====[Declarations (prototypes) of public functions]=========================
+
+void downstreamRingBufferInit( downstreamRingBuffer_t* ringBuffer );
+bool downstreamRingBufferPush( downstreamRingBuffer_t* ringBuffer, char byte );
+bool downstreamRingBufferPop( downstreamRingBuffer_t* ringBuffer, char* byte );
+
+int downstreamFrameEncode( char* frame, int frameSize, const char* payload );
+
+void downstreamFrameParserInit( downstreamFrameParser_t* parser );
+downstreamFrameType_t downstreamFrameByteProcess( downstreamFrameParser_t* parser,
+                                                  char receivedByte,
+                                                  downstreamFrame_t* frame );
+
+void downstreamLinkInit( downstreamLink_t* link );
+void downstreamLinkUpdate( downstreamLink_t* link, mergedEventLog_t* log,
+                           int panelId, int elapsedMs, bool* pollDue );
+
+void mergedEventLogInit( mergedEventLog_t* log );
+void mergedEventLogInsert( mergedEventLog_t* log, time_t seconds, int panelId,
+                           const char* typeOfEvent );
+
+//=====[#include guards - end]=================================================
+
+#endif // _PANEL_LINK_H_
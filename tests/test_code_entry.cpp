@@ -0,0 +1,206 @@
+//=====[Libraries]=============================================================
+
+#include "code_entry.h"
+
+#include <stdio.h>
+#include <string.h>
+
+//=====[Declaration of private defines]========================================
+
+#define CHECK(condition)                                                     \
+    do {                                                                     \
+        if( !(condition) ) {                                                 \
+            printf( "%s:%d: CHECK(%s) failed\n",                             \
+                    __FILE__, __LINE__, #condition );                        \
+            numberOfFailures++;                                              \
+        }                                                                    \
+    } while( 0 )
+
+//=====[Declaration and initialization of private global variables]============
+
+static int numberOfFailures = 0;
+
+//=====[Implementations of private functions]==================================
+
+static codeEntry_t codeEntryFromString( const char* keys )
+{
+    codeEntry_t entry;
+
+    codeEntryReset( &entry );
+    for( ; *keys != '\0'; keys++ ) {
+        codeEntryKeyPush( &entry, *keys );
+    }
+    return entry;
+}
+
+static userCodeAddResult_t codeAdd( userCodeTable_t* table, const char* keys )
+{
+    codeEntry_t entry = codeEntryFromString( keys );
+    return userCodeAdd( table, &entry );
+}
+
+static bool codeFind( const userCodeTable_t* table, const char* keys )
+{
+    codeEntry_t entry = codeEntryFromString( keys );
+    return userCodeFind( table, &entry );
+}
+
+static bool codeRemove( userCodeTable_t* table, const char* keys )
+{
+    codeEntry_t entry = codeEntryFromString( keys );
+    return userCodeRemove( table, &entry );
+}
+
+static void codeEntryTest()
+{
+    codeEntry_t entry;
+    char str[CODE_MAX_LENGTH + 1];
+
+    codeEntryReset( &entry );
+    CHECK( codeEntryKeyPush( &entry, '1' ) );
+    CHECK( codeEntryKeyPush( &entry, 'A' ) );
+    CHECK( codeEntryKeyPush( &entry, '*' ) );
+    CHECK( codeEntryKeyPush( &entry, 'D' ) );
+    CHECK( !codeEntryKeyPush( &entry, '#' ) );
+    CHECK( !codeEntryKeyPush( &entry, 'a' ) );
+    CHECK( !codeEntryKeyPush( &entry, '\r' ) );
+    CHECK( entry.length == 4 );
+    CHECK( codeEntryToString( &entry, str ) == 4 );
+    CHECK( strcmp( str, "1A*D" ) == 0 );
+
+    CHECK( codeEntryKeyIsValid( '0' ) && codeEntryKeyIsValid( 'C' ) &&
+           codeEntryKeyIsValid( '*' ) );
+    CHECK( !codeEntryKeyIsValid( '#' ) && !codeEntryKeyIsValid( 'E' ) &&
+           !codeEntryKeyIsValid( '\n' ) );
+
+    // Keys beyond CODE_MAX_LENGTH are not stored, but mark the entry
+    entry = codeEntryFromString( "12345678" );
+    CHECK( entry.length == CODE_MAX_LENGTH && !entry.overflow );
+    CHECK( !codeEntryKeyPush( &entry, '9' ) );
+    CHECK( entry.length == CODE_MAX_LENGTH && entry.overflow );
+    codeEntryToString( &entry, str );
+    CHECK( strcmp( str, "12345678" ) == 0 );
+}
+
+static void addFindTest()
+{
+    userCodeTable_t table;
+
+    userCodeTableInit( &table );
+    CHECK( !codeFind( &table, "1234" ) );
+    CHECK( codeAdd( &table, "1234" ) == USER_CODE_ADDED );
+    CHECK( codeFind( &table, "1234" ) );
+    CHECK( !codeFind( &table, "123" ) );
+    CHECK( !codeFind( &table, "12345" ) );
+    CHECK( !codeFind( &table, "" ) );
+
+    // Leading zeros pack to the same word; only the length tells them apart
+    CHECK( codeAdd( &table, "0" ) == USER_CODE_ADDED );
+    CHECK( !codeFind( &table, "00" ) );
+    CHECK( codeAdd( &table, "00" ) == USER_CODE_ADDED );
+    CHECK( codeFind( &table, "0" ) && codeFind( &table, "00" ) );
+    CHECK( !codeFind( &table, "000" ) );
+    CHECK( table.numberOfCodes == 3 );
+
+    // Neither an empty nor an overflowed entry is ever stored or matched
+    CHECK( codeAdd( &table, "" ) == USER_CODE_INVALID );
+    CHECK( codeAdd( &table, "123456789" ) == USER_CODE_INVALID );
+    CHECK( !codeFind( &table, "123456789" ) );
+    CHECK( codeAdd( &table, "12345678" ) == USER_CODE_ADDED );
+    CHECK( !codeFind( &table, "123456789" ) );
+    CHECK( table.numberOfCodes == 4 );
+}
+
+static void fullAndDuplicateTest()
+{
+    userCodeTable_t table;
+
+    userCodeTableInit( &table );
+    CHECK( codeAdd( &table, "1111" ) == USER_CODE_ADDED );
+    CHECK( codeAdd( &table, "2222" ) == USER_CODE_ADDED );
+
+    // Adding a stored code again is reported and takes no other entry
+    CHECK( codeAdd( &table, "1111" ) == USER_CODE_ALREADY_EXISTS );
+    CHECK( table.numberOfCodes == 2 );
+
+    CHECK( codeAdd( &table, "3333" ) == USER_CODE_ADDED );
+    CHECK( codeAdd( &table, "4444" ) == USER_CODE_ADDED );
+    CHECK( table.numberOfCodes == NUMBER_OF_USER_CODES );
+    CHECK( codeAdd( &table, "5555" ) == USER_CODE_TABLE_FULL );
+    CHECK( !codeFind( &table, "5555" ) );
+    CHECK( table.numberOfCodes == NUMBER_OF_USER_CODES );
+
+    // A duplicate is told apart from a full table
+    CHECK( codeAdd( &table, "3333" ) == USER_CODE_ALREADY_EXISTS );
+    CHECK( codeAdd( &table, "123456789" ) == USER_CODE_INVALID );
+}
+
+// "1", "4", "02" and "07" share their home slot, and "3" has the next one,
+// so they make a single probe run.
+static void collisionTest()
+{
+    userCodeTable_t table;
+
+    userCodeTableInit( &table );
+    CHECK( codeAdd( &table, "1" ) == USER_CODE_ADDED );
+    CHECK( codeAdd( &table, "4" ) == USER_CODE_ADDED );
+    CHECK( codeAdd( &table, "02" ) == USER_CODE_ADDED );
+    CHECK( codeAdd( &table, "07" ) == USER_CODE_ADDED );
+    CHECK( codeFind( &table, "1" ) && codeFind( &table, "4" ) &&
+           codeFind( &table, "02" ) && codeFind( &table, "07" ) );
+    CHECK( !codeFind( &table, "3" ) );
+
+    // Removing from the middle of the run keeps the rest reachable
+    CHECK( codeRemove( &table, "4" ) );
+    CHECK( !codeFind( &table, "4" ) );
+    CHECK( codeFind( &table, "1" ) && codeFind( &table, "02" ) &&
+           codeFind( &table, "07" ) );
+    CHECK( table.numberOfCodes == 3 );
+
+    CHECK( codeAdd( &table, "3" ) == USER_CODE_ADDED );
+    CHECK( codeRemove( &table, "1" ) );
+    CHECK( codeFind( &table, "02" ) && codeFind( &table, "07" ) &&
+           codeFind( &table, "3" ) );
+    CHECK( !codeRemove( &table, "1" ) );
+
+    CHECK( codeAdd( &table, "4" ) == USER_CODE_ADDED );
+    CHECK( codeFind( &table, "4" ) );
+    CHECK( table.numberOfCodes == 4 );
+}
+
+static void removeTest()
+{
+    userCodeTable_t table;
+
+    userCodeTableInit( &table );
+    CHECK( codeAdd( &table, "1234" ) == USER_CODE_ADDED );
+    CHECK( codeAdd( &table, "5678" ) == USER_CODE_ADDED );
+    CHECK( !codeRemove( &table, "9999" ) );
+    CHECK( !codeRemove( &table, "123" ) );
+    CHECK( codeRemove( &table, "1234" ) );
+    CHECK( !codeFind( &table, "1234" ) );
+    CHECK( codeFind( &table, "5678" ) );
+
+    // The last code is kept, so that the alarm can always be deactivated
+    CHECK( !codeRemove( &table, "5678" ) );
+    CHECK( codeFind( &table, "5678" ) );
+    CHECK( table.numberOfCodes == 1 );
+}
+
+//=====[Main function, the program entry point]================================
+
+int main()
+{
+    codeEntryTest();
+    addFindTest();
+    fullAndDuplicateTest();
+    collisionTest();
+    removeTest();
+
+    if( numberOfFailures > 0 ) {
+        printf( "test_code_entry: %d check(s) failed\n", numberOfFailures );
+        return 1;
+    }
+    printf( "test_code_entry: all checks passed\n" );
+    return 0;
+}
@@ -0,0 +1,326 @@
+//=====[Libraries]=============================================================
+
+#include "panel_link.h"
+
+#include <stdio.h>
+#include <string.h>
+
+//=====[Declaration of private defines]========================================
+
+#define CHECK(condition)                                                     \
+    do {                                                                     \
+        if( !(condition) ) {                                                 \
+            printf( "%s:%d: CHECK(%s) failed\n",                             \
+                    __FILE__, __LINE__, #condition );                        \
+            numberOfFailures++;                                              \
+        }                                                                    \
+    } while( 0 )
+
+//=====[Declaration and initialization of private global variables]============
+
+static int numberOfFailures = 0;
+
+//=====[Implementations of private functions]==================================
+
+static downstreamFrameType_t streamFeed( downstreamFrameParser_t* parser,
+                                         const char* stream,
+                                         downstreamFrame_t* frame )
+{
+    downstreamFrameType_t lastFrameType = DOWNSTREAM_FRAME_NONE;
+    downstreamFrameType_t frameType;
+
+    for( ; *stream != '\0'; stream++ ) {
+        frameType = downstreamFrameByteProcess( parser, *stream, frame );
+        if( frameType != DOWNSTREAM_FRAME_NONE ) {
+            lastFrameType = frameType;
+        }
+    }
+    return lastFrameType;
+}
+
+static downstreamFrameType_t payloadFeed( const char* payload,
+                                          downstreamFrame_t* frame )
+{
+    downstreamFrameParser_t parser;
+    char stream[DOWNSTREAM_FRAME_MAX_LENGTH + 8];
+
+    downstreamFrameParserInit( &parser );
+    if( downstreamFrameEncode( stream, sizeof(stream), payload ) == 0 ) {
+        return DOWNSTREAM_FRAME_NONE;
+    }
+    return streamFeed( &parser, stream, frame );
+}
+
+static void ringBufferTest()
+{
+    downstreamRingBuffer_t ringBuffer;
+    char byte;
+    int i;
+
+    downstreamRingBufferInit( &ringBuffer );
+    CHECK( !downstreamRingBufferPop( &ringBuffer, &byte ) );
+
+    for( i=0; i<DOWNSTREAM_RX_BUFFER_SIZE - 1; i++ ) {
+        CHECK( downstreamRingBufferPush( &ringBuffer, (char) i ) );
+    }
+    CHECK( !downstreamRingBufferPush( &ringBuffer, 'x' ) );
+
+    for( i=0; i<DOWNSTREAM_RX_BUFFER_SIZE - 1; i++ ) {
+        CHECK( downstreamRingBufferPop( &ringBuffer, &byte ) );
+        CHECK( byte == (char) i );
+    }
+    CHECK( !downstreamRingBufferPop( &ringBuffer, &byte ) );
+}
+
+static void eventFrameTest()
+{
+    downstreamFrameParser_t parser;
+    downstreamFrame_t frame;
+    char stream[DOWNSTREAM_FRAME_MAX_LENGTH + 8];
+
+    CHECK( payloadFeed( "E,7,1700000000,ALARM_ON", &frame ) ==
+           DOWNSTREAM_FRAME_EVENT );
+    CHECK( frame.sequence == 7 );
+    CHECK( frame.seconds == 1700000000 );
+    CHECK( strcmp( frame.typeOfEvent, "ALARM_ON" ) == 0 );
+
+    // Frames are picked out of regular console text
+    downstreamFrameParserInit( &parser );
+    downstreamFrameEncode( stream, sizeof(stream), "E,255,42,GAS_DET_ON" );
+    CHECK( streamFeed( &parser, "2024-01-01 00:00:42  GAS_DET_ON\r\n",
+                       &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( streamFeed( &parser, stream, &frame ) == DOWNSTREAM_FRAME_EVENT );
+    CHECK( frame.sequence == 255 );
+    CHECK( frame.seconds == 42 );
+    CHECK( strcmp( frame.typeOfEvent, "GAS_DET_ON" ) == 0 );
+
+    // Lower case checksum digits are accepted
+    downstreamFrameParserInit( &parser );
+    CHECK( streamFeed( &parser, "$S,0,0,0,0,0,0*53\r\n", &frame ) ==
+           DOWNSTREAM_FRAME_STATUS );
+
+    CHECK( payloadFeed( "E,0,,ALARM_ON", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "E,0,12,", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "E,0,12", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "E,0,1x,ALARM_ON", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "E,0,12,ALARM,ON", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "E,0,12,EVENT_NAME_TOO_LONG", &frame ) ==
+           DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "E,0,123456789012,ALARM_ON", &frame ) ==
+           DOWNSTREAM_FRAME_NONE );
+
+    // The sequence number is 0 to 255 and cannot be left out
+    CHECK( payloadFeed( "E,12,ALARM_ON", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "E,,12,ALARM_ON", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "E,256,12,ALARM_ON", &frame ) ==
+           DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "E,0001,12,ALARM_ON", &frame ) ==
+           DOWNSTREAM_FRAME_NONE );
+}
+
+static void statusFrameTest()
+{
+    downstreamFrame_t frame;
+
+    CHECK( payloadFeed( "S,1,0,1,0,1,42", &frame ) == DOWNSTREAM_FRAME_STATUS );
+    CHECK( frame.sequence == 42 );
+    CHECK( frame.status.online );
+    CHECK( frame.status.alarm );
+    CHECK( !frame.status.gasDetector );
+    CHECK( frame.status.overTempDetector );
+    CHECK( !frame.status.incorrectCode );
+    CHECK( frame.status.systemBlocked );
+
+    CHECK( payloadFeed( "S,1,0,1,0,2,0", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "S,1;0,1,0,1,0", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "SX1,0,1,0,1,0", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "S,1,0,1,0,,0", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "S,1,0,1,0,1", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "S,1,0,1,0,1,", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "S,1,0,1,0,1,256", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "S,1,0,1,0,1,0,", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( payloadFeed( "X,1,0,1,0,1,0", &frame ) == DOWNSTREAM_FRAME_NONE );
+}
+
+static void checksumTest()
+{
+    downstreamFrameParser_t parser;
+    downstreamFrame_t frame;
+    char stream[DOWNSTREAM_FRAME_MAX_LENGTH + 8];
+    int length;
+
+    length = downstreamFrameEncode( stream, sizeof(stream), "S,0,0,0,0,0,0" );
+    CHECK( strcmp( stream, "$S,0,0,0,0,0,0*53\r\n" ) == 0 );
+
+    // Corrupted payload byte
+    downstreamFrameParserInit( &parser );
+    stream[3] = '1';
+    CHECK( streamFeed( &parser, stream, &frame ) == DOWNSTREAM_FRAME_NONE );
+
+    // Wrong checksum value
+    downstreamFrameParserInit( &parser );
+    CHECK( streamFeed( &parser, "$S,0,0,0,0,0,0*52\r\n", &frame ) ==
+           DOWNSTREAM_FRAME_NONE );
+
+    // Checksum must be exactly two hex digits
+    downstreamFrameParserInit( &parser );
+    CHECK( streamFeed( &parser, "$S,0,0,0,0,0,0*+3\r\n", &frame ) ==
+           DOWNSTREAM_FRAME_NONE );
+    CHECK( streamFeed( &parser, "$S,0,0,0,0,0,0* 53\r\n", &frame ) ==
+           DOWNSTREAM_FRAME_NONE );
+    CHECK( streamFeed( &parser, "$S,0,0,0,0,0,0*5\r\n", &frame ) ==
+           DOWNSTREAM_FRAME_NONE );
+    CHECK( streamFeed( &parser, "$S,0,0,0,0,0,0*053\r\n", &frame ) ==
+           DOWNSTREAM_FRAME_NONE );
+    CHECK( streamFeed( &parser, "$S,0,0,0,0,0,0\r\n", &frame ) ==
+           DOWNSTREAM_FRAME_NONE );
+    CHECK( streamFeed( &parser, "$*00\r\n", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( length == (int) strlen( "$S,0,0,0,0,0,0*53\r\n" ) );
+}
+
+static void tooLongFrameTest()
+{
+    downstreamFrameParser_t parser;
+    downstreamFrame_t frame;
+    char stream[2 * DOWNSTREAM_FRAME_MAX_LENGTH];
+    char payload[DOWNSTREAM_FRAME_MAX_LENGTH];
+
+    memset( payload, 'A', sizeof(payload) - 1 );
+    payload[sizeof(payload) - 1] = '\0';
+    CHECK( downstreamFrameEncode( stream, sizeof(stream), payload ) == 0 );
+
+    // An over-long frame is dropped, and the parser recovers on the next '$'
+    downstreamFrameParserInit( &parser );
+    CHECK( streamFeed( &parser, "$E,0,1,", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( streamFeed( &parser, payload, &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( streamFeed( &parser, "*00\r\n", &frame ) == DOWNSTREAM_FRAME_NONE );
+    downstreamFrameEncode( stream, sizeof(stream), "E,0,7,ALARM_OFF" );
+    CHECK( streamFeed( &parser, stream, &frame ) == DOWNSTREAM_FRAME_EVENT );
+    CHECK( frame.seconds == 7 );
+
+    // A frame cut short by a new '$' is dropped too
+    downstreamFrameParserInit( &parser );
+    CHECK( streamFeed( &parser, "$E,0,1,ALA", &frame ) == DOWNSTREAM_FRAME_NONE );
+    CHECK( streamFeed( &parser, stream, &frame ) == DOWNSTREAM_FRAME_EVENT );
+}
+
+static void linkFramesFeed( downstreamLink_t* link, mergedEventLog_t* log,
+                            const char* payload )
+{
+    char stream[DOWNSTREAM_FRAME_MAX_LENGTH + 8];
+    bool pollDue;
+    int i;
+
+    downstreamFrameEncode( stream, sizeof(stream), payload );
+    for( i=0; stream[i] != '\0'; i++ ) {
+        downstreamRingBufferPush( &link->rxBuffer, stream[i] );
+    }
+    downstreamLinkUpdate( link, log, 1, 0, &pollDue );
+}
+
+static void lostEventsTest()
+{
+    static mergedEventLog_t log;
+    downstreamLink_t link;
+
+    mergedEventLogInit( &log );
+    downstreamLinkInit( &link );
+
+    // Numbering is taken from the status frame that brings the panel online
+    linkFramesFeed( &link, &log, "E,3,10,ALARM_ON" );
+    linkFramesFeed( &link, &log, "S,1,0,0,0,0,4" );
+    linkFramesFeed( &link, &log, "E,4,11,LED_IC_ON" );
+    linkFramesFeed( &link, &log, "E,5,12,LED_IC_OFF" );
+    CHECK( link.numberOfLostEvents == 0 );
+
+    // Two events cut out of the stream
+    linkFramesFeed( &link, &log, "E,8,15,ALARM_OFF" );
+    CHECK( link.numberOfLostEvents == 2 );
+
+    // A status frame shows an event lost after the last one received
+    linkFramesFeed( &link, &log, "S,0,0,0,0,0,10" );
+    CHECK( link.numberOfLostEvents == 3 );
+
+    // Numbering wraps around
+    downstreamLinkInit( &link );
+    linkFramesFeed( &link, &log, "S,0,0,0,0,0,254" );
+    linkFramesFeed( &link, &log, "E,254,20,ALARM_ON" );
+    linkFramesFeed( &link, &log, "E,255,21,ALARM_OFF" );
+    linkFramesFeed( &link, &log, "E,0,22,ALARM_ON" );
+    linkFramesFeed( &link, &log, "S,1,0,0,0,0,1" );
+    CHECK( link.numberOfLostEvents == 0 );
+    linkFramesFeed( &link, &log, "E,3,25,ALARM_OFF" );
+    CHECK( link.numberOfLostEvents == 2 );
+    CHECK( log.numberOfEvents == 8 );
+}
+
+static void mergedEventLogTest()
+{
+    static mergedEventLog_t log;
+    int i;
+
+    mergedEventLogInit( &log );
+    mergedEventLogInsert( &log, 20, 1, "ALARM_ON" );
+    mergedEventLogInsert( &log, 10, 2, "GAS_DET_ON" );
+    mergedEventLogInsert( &log, 30, 0, "LED_IC_ON" );
+    mergedEventLogInsert( &log, 20, 2, "ALARM_ON" );
+    mergedEventLogInsert( &log, 5, 1, "OVER_TEMP_ON" );
+
+    CHECK( log.numberOfEvents == 5 );
+    CHECK( log.events[0].seconds == 5 );
+    CHECK( log.events[1].seconds == 10 );
+    CHECK( log.events[2].seconds == 20 && log.events[2].panelId == 1 );
+    CHECK( log.events[3].seconds == 20 && log.events[3].panelId == 2 );
+    CHECK( log.events[4].seconds == 30 );
+    CHECK( strcmp( log.events[0].typeOfEvent, "OVER_TEMP_ON" ) == 0 );
+
+    // Names are truncated to fit
+    mergedEventLogInit( &log );
+    mergedEventLogInsert( &log, 1, 0, "A_VERY_LONG_EVENT_NAME" );
+    CHECK( strlen( log.events[0].typeOfEvent ) ==
+           MERGED_EVENT_NAME_MAX_LENGTH - 1 );
+
+    // A full log drops its oldest event
+    mergedEventLogInit( &log );
+    for( i=0; i<MERGED_EVENT_MAX_STORAGE; i++ ) {
+        mergedEventLogInsert( &log, 100 + 2 * i, 1, "ALARM_ON" );
+    }
+    CHECK( log.numberOfEvents == MERGED_EVENT_MAX_STORAGE );
+
+    mergedEventLogInsert( &log, 101, 2, "GAS_DET_ON" );
+    CHECK( log.numberOfEvents == MERGED_EVENT_MAX_STORAGE );
+    CHECK( log.events[0].seconds == 101 && log.events[0].panelId == 2 );
+    CHECK( log.events[1].seconds == 102 );
+
+    mergedEventLogInsert( &log, 1000, 2, "GAS_DET_OFF" );
+    CHECK( log.events[0].seconds == 102 );
+    CHECK( log.events[MERGED_EVENT_MAX_STORAGE - 1].seconds == 1000 );
+
+    // An event older than everything in a full log is not kept
+    mergedEventLogInsert( &log, 1, 2, "LED_SB_ON" );
+    CHECK( log.events[0].seconds == 102 );
+
+    for( i=1; i<log.numberOfEvents; i++ ) {
+        CHECK( log.events[i - 1].seconds <= log.events[i].seconds );
+    }
+}
+
+//=====[Main function, the program entry point]================================
+
+int main()
+{
+    ringBufferTest();
+    eventFrameTest();
+    statusFrameTest();
+    checksumTest();
+    tooLongFrameTest();
+    lostEventsTest();
+    mergedEventLogTest();
+
+    if( numberOfFailures > 0 ) {
+        printf( "test_panel_link: %d check(s) failed\n", numberOfFailures );
+        return 1;
+    }
+    printf( "test_panel_link: all checks passed\n" );
+    return 0;
+}
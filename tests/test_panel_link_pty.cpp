@@ -0,0 +1,320 @@
+//=====[Libraries]=============================================================
+
+#include "panel_link.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+//=====[Declaration of private defines]========================================
+
+#define NUMBER_OF_PTY_LINKS                      2
+#define TIME_INCREMENT_MS                       10
+
+#define CHECK(condition)                                                     \
+    do {                                                                     \
+        if( !(condition) ) {                                                 \
+            printf( "%s:%d: CHECK(%s) failed\n",                             \
+                    __FILE__, __LINE__, #condition );                        \
+            numberOfFailures++;                                              \
+        }                                                                    \
+    } while( 0 )
+
+//=====[Declaration of private data types]=====================================
+
+// A pseudo-terminal pair standing in for one physical link: the
+// concentrator owns the master side, the downstream panel the slave side.
+typedef struct ptyLink {
+    int concentratorFd;
+    int panelFd;
+    downstreamLink_t link;
+} ptyLink_t;
+
+//=====[Declaration and initialization of private global variables]============
+
+static int numberOfFailures = 0;
+static ptyLink_t ptyLinks[NUMBER_OF_PTY_LINKS];
+static mergedEventLog_t mergedEventLog;
+
+//=====[Implementations of private functions]==================================
+
+static bool ptyLinkOpen( ptyLink_t* ptyLink )
+{
+    struct termios settings;
+
+    ptyLink->concentratorFd = posix_openpt( O_RDWR | O_NOCTTY | O_NONBLOCK );
+    if( ptyLink->concentratorFd < 0 ||
+        grantpt( ptyLink->concentratorFd ) != 0 ||
+        unlockpt( ptyLink->concentratorFd ) != 0 ) {
+        return false;
+    }
+    ptyLink->panelFd = open( ptsname( ptyLink->concentratorFd ),
+                             O_RDWR | O_NOCTTY | O_NONBLOCK );
+    if( ptyLink->panelFd < 0 || tcgetattr( ptyLink->panelFd, &settings ) != 0 ) {
+        return false;
+    }
+    cfmakeraw( &settings );
+    tcsetattr( ptyLink->panelFd, TCSANOW, &settings );
+
+    downstreamLinkInit( &ptyLink->link );
+    return true;
+}
+
+static void ptyLinkClose( ptyLink_t* ptyLink )
+{
+    close( ptyLink->panelFd );
+    close( ptyLink->concentratorFd );
+}
+
+static void panelWrite( ptyLink_t* ptyLink, const char* text )
+{
+    CHECK( write( ptyLink->panelFd, text, strlen( text ) ) ==
+           (ssize_t) strlen( text ) );
+    tcdrain( ptyLink->panelFd );
+}
+
+static void panelFrameWrite( ptyLink_t* ptyLink, const char* payload )
+{
+    char frame[DOWNSTREAM_FRAME_MAX_LENGTH + 8];
+    CHECK( downstreamFrameEncode( frame, sizeof(frame), payload ) > 0 );
+    panelWrite( ptyLink, frame );
+}
+
+// Number of poll requests the panel side has received since last asked
+static int panelPollsRead( ptyLink_t* ptyLink )
+{
+    char receivedByte;
+    int numberOfPolls = 0;
+
+    while( read( ptyLink->panelFd, &receivedByte, 1 ) == 1 ) {
+        if( receivedByte == DOWNSTREAM_POLL_REQUEST ) {
+            numberOfPolls++;
+        }
+    }
+    return numberOfPolls;
+}
+
+// One main loop pass of the concentrator: the pty read stands in for the RX
+// interrupt, the rest is the firmware's own service step.
+static void ptyLinksService()
+{
+    const char pollRequest = DOWNSTREAM_POLL_REQUEST;
+    char receivedByte;
+    bool pollDue;
+    int i;
+
+    usleep( 1000 );
+    for( i=0; i<NUMBER_OF_PTY_LINKS; i++ ) {
+        ptyLink_t* ptyLink = &ptyLinks[i];
+
+        while( read( ptyLink->concentratorFd, &receivedByte, 1 ) == 1 ) {
+            downstreamRingBufferPush( &ptyLink->link.rxBuffer, receivedByte );
+        }
+        downstreamLinkUpdate( &ptyLink->link, &mergedEventLog, i + 1,
+                              TIME_INCREMENT_MS, &pollDue );
+        if( pollDue ) {
+            CHECK( write( ptyLink->concentratorFd, &pollRequest, 1 ) == 1 );
+        }
+    }
+}
+
+static void ptyLinksServiceFor( int timeMs )
+{
+    int elapsedMs;
+    for( elapsedMs=0; elapsedMs<timeMs; elapsedMs=elapsedMs+TIME_INCREMENT_MS ) {
+        ptyLinksService();
+    }
+}
+
+static void mergeTest()
+{
+    // Panels interleave frames with their normal console output, and
+    // their clocks make the events arrive out of order across links
+    panelWrite( &ptyLinks[0], "2024-01-01 00:00:30  ALARM_ON\r\n" );
+    panelFrameWrite( &ptyLinks[0], "E,0,30,ALARM_ON" );
+    panelFrameWrite( &ptyLinks[1], "E,0,10,GAS_DET_ON" );
+    panelWrite( &ptyLinks[1], "Available commands:\r\n" );
+    panelFrameWrite( &ptyLinks[1], "E,1,40,GAS_DET_OFF" );
+    panelFrameWrite( &ptyLinks[0], "E,1,20,OVER_TEMP_ON" );
+    panelWrite( &ptyLinks[0], "$E,2,25,LED_IC_ON*00\r\n" );
+    ptyLinksServiceFor( 5 * TIME_INCREMENT_MS );
+
+    CHECK( mergedEventLog.numberOfEvents == 4 );
+    CHECK( mergedEventLog.events[0].seconds == 10 &&
+           mergedEventLog.events[0].panelId == 2 );
+    CHECK( mergedEventLog.events[1].seconds == 20 &&
+           mergedEventLog.events[1].panelId == 1 );
+    CHECK( mergedEventLog.events[2].seconds == 30 &&
+           mergedEventLog.events[2].panelId == 1 );
+    CHECK( mergedEventLog.events[3].seconds == 40 &&
+           mergedEventLog.events[3].panelId == 2 );
+}
+
+static void pollTest()
+{
+    int i;
+
+    for( i=0; i<NUMBER_OF_PTY_LINKS; i++ ) {
+        downstreamLinkInit( &ptyLinks[i].link );
+        panelPollsRead( &ptyLinks[i] );
+    }
+
+    // No poll before DOWNSTREAM_POLL_TIME_MS, exactly one when it elapses
+    ptyLinksServiceFor( DOWNSTREAM_POLL_TIME_MS - TIME_INCREMENT_MS );
+    CHECK( panelPollsRead( &ptyLinks[0] ) == 0 );
+    ptyLinksServiceFor( TIME_INCREMENT_MS );
+    usleep( 1000 );
+    CHECK( panelPollsRead( &ptyLinks[0] ) == 1 );
+    CHECK( panelPollsRead( &ptyLinks[1] ) == 1 );
+
+    // Then one per interval
+    ptyLinksServiceFor( 3 * DOWNSTREAM_POLL_TIME_MS );
+    usleep( 1000 );
+    CHECK( panelPollsRead( &ptyLinks[0] ) == 3 );
+}
+
+static void timeoutTest()
+{
+    int i;
+
+    for( i=0; i<NUMBER_OF_PTY_LINKS; i++ ) {
+        downstreamLinkInit( &ptyLinks[i].link );
+    }
+    ptyLinksService();
+    CHECK( !ptyLinks[0].link.status.online );
+    CHECK( !ptyLinks[1].link.status.online );
+
+    // Status frame in answer to a poll
+    panelFrameWrite( &ptyLinks[1], "S,1,1,0,0,0,0" );
+    ptyLinksService();
+    CHECK( ptyLinks[1].link.status.online );
+    CHECK( ptyLinks[1].link.status.alarm );
+    CHECK( ptyLinks[1].link.status.gasDetector );
+    CHECK( !ptyLinks[1].link.status.overTempDetector );
+    CHECK( !ptyLinks[0].link.status.online );
+
+    // A bad frame does not keep the link alive; it goes offline once
+    // DOWNSTREAM_LINK_TIMEOUT_MS has passed since the last valid frame
+    ptyLinksServiceFor( DOWNSTREAM_LINK_TIMEOUT_MS / 2 );
+    panelWrite( &ptyLinks[1], "$S,1,1,0,0,0,0*00\r\n" );
+    ptyLinksServiceFor( DOWNSTREAM_LINK_TIMEOUT_MS / 2 -
+                        2 * TIME_INCREMENT_MS );
+    CHECK( ptyLinks[1].link.status.online );
+    ptyLinksServiceFor( 2 * TIME_INCREMENT_MS );
+    CHECK( !ptyLinks[1].link.status.online );
+
+    // A valid frame restarts the timeout
+    panelFrameWrite( &ptyLinks[1], "S,0,0,0,0,0,0" );
+    ptyLinksServiceFor( DOWNSTREAM_LINK_TIMEOUT_MS - TIME_INCREMENT_MS );
+    CHECK( ptyLinks[1].link.status.online );
+    panelFrameWrite( &ptyLinks[1], "S,0,0,0,0,0,0" );
+    ptyLinksServiceFor( DOWNSTREAM_LINK_TIMEOUT_MS - TIME_INCREMENT_MS );
+    CHECK( ptyLinks[1].link.status.online );
+    ptyLinksServiceFor( TIME_INCREMENT_MS );
+    CHECK( !ptyLinks[1].link.status.online );
+}
+
+static void eventFromOfflineLinkTest()
+{
+    downstreamLinkInit( &ptyLinks[0].link );
+    panelPollsRead( &ptyLinks[0] );
+
+    // An event alone does not bring the panel online with unknown flags,
+    // but gets it polled at once instead of at the next interval
+    panelFrameWrite( &ptyLinks[0], "E,7,50,ALARM_ON" );
+    ptyLinksService();
+    usleep( 1000 );
+    CHECK( !ptyLinks[0].link.status.online );
+    CHECK( panelPollsRead( &ptyLinks[0] ) == 1 );
+    CHECK( mergedEventLog.events[mergedEventLog.numberOfEvents - 1].seconds ==
+           50 );
+
+    panelFrameWrite( &ptyLinks[0], "S,1,0,0,0,0,8" );
+    ptyLinksService();
+    CHECK( ptyLinks[0].link.status.online );
+    CHECK( ptyLinks[0].link.status.alarm );
+
+    // Once online, events do not trigger extra polls
+    panelFrameWrite( &ptyLinks[0], "E,8,51,ALARM_OFF" );
+    ptyLinksService();
+    usleep( 1000 );
+    CHECK( panelPollsRead( &ptyLinks[0] ) == 0 );
+    CHECK( ptyLinks[0].link.numberOfLostEvents == 0 );
+}
+
+// Frames written by the panel while the concentrator is not servicing its
+// links, as during a long console write
+static void panelEventBurstWrite( ptyLink_t* ptyLink, int firstSequence,
+                                  int numberOfEvents )
+{
+    char payload[DOWNSTREAM_FRAME_MAX_LENGTH];
+    int i;
+
+    for( i=0; i<numberOfEvents; i++ ) {
+        snprintf( payload, sizeof(payload), "E,%d,%d,ALARM_ON",
+                  ( firstSequence + i ) % DOWNSTREAM_EVENT_SEQUENCE_MODULO,
+                  1000 + i );
+        panelFrameWrite( ptyLink, payload );
+    }
+}
+
+static void burstTest()
+{
+    int numberOfEvents;
+
+    downstreamLinkInit( &ptyLinks[1].link );
+    panelFrameWrite( &ptyLinks[1], "S,0,0,0,0,0,0" );
+    ptyLinksService();
+    CHECK( ptyLinks[1].link.status.online );
+
+    // A burst that fits in the RX buffer gets through whole
+    mergedEventLogInit( &mergedEventLog );
+    panelEventBurstWrite( &ptyLinks[1], 0, 30 );
+    ptyLinksService();
+    CHECK( mergedEventLog.numberOfEvents == 30 );
+    CHECK( ptyLinks[1].link.numberOfLostEvents == 0 );
+
+    // What overflows it is reported as lost once the next event arrives
+    panelEventBurstWrite( &ptyLinks[1], 30, 60 );
+    ptyLinksService();
+    panelEventBurstWrite( &ptyLinks[1], 90, 1 );
+    ptyLinksService();
+    numberOfEvents = mergedEventLog.numberOfEvents - 30;
+    CHECK( numberOfEvents < 61 );
+    CHECK( ptyLinks[1].link.numberOfLostEvents == 61 - numberOfEvents );
+}
+
+//=====[Main function, the program entry point]================================
+
+int main()
+{
+    int i;
+
+    for( i=0; i<NUMBER_OF_PTY_LINKS; i++ ) {
+        if( !ptyLinkOpen( &ptyLinks[i] ) ) {
+            printf( "test_panel_link_pty: pseudo-terminals not available\n" );
+            return 1;
+        }
+    }
+    mergedEventLogInit( &mergedEventLog );
+
+    mergeTest();
+    pollTest();
+    timeoutTest();
+    eventFromOfflineLinkTest();
+    burstTest();
+
+    for( i=0; i<NUMBER_OF_PTY_LINKS; i++ ) {
+        ptyLinkClose( &ptyLinks[i] );
+    }
+
+    if( numberOfFailures > 0 ) {
+        printf( "test_panel_link_pty: %d check(s) failed\n", numberOfFailures );
+        return 1;
+    }
+    printf( "test_panel_link_pty: all checks passed\n" );
+    return 0;
+}